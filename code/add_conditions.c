@@ -96,6 +96,78 @@ void all_regions_max_one_side_product(CNF* formula, unsigned num_of_regions, uns
     }
 }
 
+/** Pomocná funkce vytvářející sekvenční kódování podmínky, že v daném regionu
+* je produkován nejvýše jeden produkt daného typu. Pomocná proměnná s_p
+* říká, že některý z produktů 0, ..., p je v regionu produkován.
+* @param formula výroková formule, do níž bude klauzule přidána
+* @param is_main_product příznak udávající, zda jde o hlavní produkty
+* @param region index regionu
+* @param num_of_products počet produktů
+*/
+void region_max_one_product_sequential(CNF* formula, bool is_main_product, unsigned region, unsigned num_of_products) {
+    assert(formula != NULL);
+
+    if (num_of_products < 2) { return; }
+
+    uint64_t prev = new_aux_variable(formula);
+    Clause* cl = create_new_clause(formula);
+    add_literal_to_clause(cl, false, is_main_product, region, 0);       //  ¬x{k,0} ∨ s_0
+    add_aux_literal_to_clause(cl, true, prev);
+
+    for (unsigned p = 1; p + 1 < num_of_products; ++p) {
+        uint64_t next = new_aux_variable(formula);
+
+        cl = create_new_clause(formula);
+        add_literal_to_clause(cl, false, is_main_product, region, p);   //  ¬x{k,p} ∨ s_p
+        add_aux_literal_to_clause(cl, true, next);
+
+        cl = create_new_clause(formula);
+        add_aux_literal_to_clause(cl, false, prev);                     //  ¬s_{p-1} ∨ s_p
+        add_aux_literal_to_clause(cl, true, next);
+
+        cl = create_new_clause(formula);
+        add_literal_to_clause(cl, false, is_main_product, region, p);   //  ¬x{k,p} ∨ ¬s_{p-1}
+        add_aux_literal_to_clause(cl, false, prev);
+
+        prev = next;
+    }
+
+    cl = create_new_clause(formula);
+    add_literal_to_clause(cl, false, is_main_product, region, num_of_products - 1);     //  ¬x{k,P-1} ∨ ¬s_{P-2}
+    add_aux_literal_to_clause(cl, false, prev);
+}
+
+/** Varianta funkce all_regions_max_one_main_product využívající sekvenční
+* kódování (sequential counter) s pomocnými proměnnými. Místo P(P-1)/2 klauzulí
+* na region párového kódování vytváří 3P-4 klauzulí a P-1 pomocných proměnných.
+* @param formula výroková formule, do níž bude klauzule přidána
+* @param num_of_regions počet regionů
+* @param num_of_products počet produktů
+*/
+void all_regions_max_one_main_product_sequential(CNF* formula, unsigned num_of_regions, unsigned num_of_products) {
+    assert(formula != NULL);
+    assert(num_of_regions > 0);
+
+    for (unsigned k = 0; k < num_of_regions; ++k) {
+        region_max_one_product_sequential(formula, MAIN_PRODUCT, k, num_of_products);
+    }
+}
+
+/** Varianta funkce all_regions_max_one_side_product využívající sekvenční
+* kódování (sequential counter) s pomocnými proměnnými.
+* @param formula výroková formule, do níž bude klauzule přidána
+* @param num_of_regions počet regionů
+* @param num_of_products počet produktů
+*/
+void all_regions_max_one_side_product_sequential(CNF* formula, unsigned num_of_regions, unsigned num_of_products) {
+    assert(formula != NULL);
+    assert(num_of_regions > 0);
+
+    for (unsigned k = 0; k < num_of_regions; ++k) {
+        region_max_one_product_sequential(formula, SIDE_PRODUCT, k, num_of_products);
+    }
+}
+
 /** Funkce vytvářející klauzule ošetřující podmínku, že v každém regionu
 * se hlavní a vedlejší produkt liší
 * @param formula výroková formule, do níž bude klauzule přidána
@@ -195,6 +267,22 @@ void main_region_main_product_as_side_product_elsewhere(CNF* formula, unsigned n
         }
 }
 
+/** Funkce přidávající klauzuli, která láme symetrii mezi produkty.
+* Všechny podmínky zacházejí se všemi produkty stejně, lze tedy bez újmy
+* na splnitelnosti určit hlavní produkt regionu 0 jako produkt 0.
+* @param formula výroková formule, do níž bude klauzule přidána
+* @param num_of_regions počet regionů
+* @param num_of_products počet produktů
+*/
+void break_product_symmetry(CNF* formula, unsigned num_of_regions, unsigned num_of_products) {
+    assert(formula != NULL);
+    assert(num_of_regions > 0);
+    assert(num_of_products > 0);
+
+    Clause* cl = create_new_clause(formula);
+    add_literal_to_clause(cl, true, MAIN_PRODUCT, 0, 0);
+}
+
 /** Bonusová funkce k projektu
 * @return vrací bonusovou odpověď
 */
@@ -2,6 +2,7 @@
 #define __CNF_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <assert.h>
 
 #define MAIN_PRODUCT true
@@ -33,6 +34,20 @@ Clause* create_new_clause(CNF *formula);
 */
 void add_literal_to_clause(Clause *clause, bool is_positive, bool is_main_product, unsigned region, unsigned product);
 
+/** Funkce vytvoří novou pomocnou proměnnou. Pomocné proměnné mají indexy
+* za všemi proměnnými h_{k,p} a v_{k,p}.
+* @param formula výroková formule
+* @return číslo pomocné proměnné (číslováno od 1)
+*/
+uint64_t new_aux_variable(CNF *formula);
+
+/** Funkce přidá do klauzule literál pomocné proměnné.
+* @param clause klauzule
+* @param is_positive příznak udávající, zda je proměnná pozitivní
+* @param aux číslo pomocné proměnné vrácené funkcí new_aux_variable
+*/
+void add_aux_literal_to_clause(Clause *clause, bool is_positive, uint64_t aux);
+
 /** Funkce demonstrující vytvoření nové (arbitrárně vybrané) klauzule
 * ve tvaru "h_{0,1} || -v_{0,1}" do výrokové formule
 * @param formula výroková formule, do níž bude klauzule přidána
@@ -63,6 +78,23 @@ void all_regions_max_one_main_product(CNF* formula, unsigned num_of_regions, uns
 */
 void all_regions_max_one_side_product(CNF* formula, unsigned num_of_regions, unsigned num_of_products);
 
+/** Varianta funkce all_regions_max_one_main_product využívající sekvenční
+* kódování (sequential counter) s pomocnými proměnnými. Místo P(P-1)/2 klauzulí
+* na region párového kódování vytváří 3P-4 klauzulí a P-1 pomocných proměnných.
+* @param formula výroková formule, do níž bude klauzule přidána
+* @param num_of_regions počet regionů
+* @param num_of_products počet produktů
+*/
+void all_regions_max_one_main_product_sequential(CNF* formula, unsigned num_of_regions, unsigned num_of_products);
+
+/** Varianta funkce all_regions_max_one_side_product využívající sekvenční
+* kódování (sequential counter) s pomocnými proměnnými.
+* @param formula výroková formule, do níž bude klauzule přidána
+* @param num_of_regions počet regionů
+* @param num_of_products počet produktů
+*/
+void all_regions_max_one_side_product_sequential(CNF* formula, unsigned num_of_regions, unsigned num_of_products);
+
 /** Funkce vytvářející klauzule ošetřující podmínku, že v každém regionu
 * se hlavní a vedlejší produkt liší
 * @param formula výroková formule, do níž bude klauzule přidána
@@ -106,6 +138,15 @@ void no_side_product_in_main_region(CNF* formula, unsigned num_of_regions, unsig
 */
 void main_region_main_product_as_side_product_elsewhere(CNF* formula, unsigned num_of_regions, unsigned num_of_products);
 
+/** Funkce přidávající klauzuli, která láme symetrii mezi produkty.
+* Všechny podmínky zacházejí se všemi produkty stejně, lze tedy bez újmy
+* na splnitelnosti určit hlavní produkt regionu 0 jako produkt 0.
+* @param formula výroková formule, do níž bude klauzule přidána
+* @param num_of_regions počet regionů
+* @param num_of_products počet produktů
+*/
+void break_product_symmetry(CNF* formula, unsigned num_of_regions, unsigned num_of_products);
+
 /** Predikát rozhodující, zda dané dva indexy odpovídají sousedícím regionům
 * @param lists seznam sousedů
 * @param fst první region
@@ -1,5 +1,11 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <inttypes.h>
 
 #include "cnf.h"
 
@@ -11,6 +17,27 @@ void error(char* error_msg) {
     exit(-1);
 }
 
+/** Funkce načte nezáporné celé číslo z argumentu příkazové řádky
+* @param arg argument příkazové řádky
+* @param max největší povolená hodnota
+* @param value načtená hodnota
+* @return true, pokud argument obsahuje pouze číslo nepřesahující max
+*/
+bool parse_number(const char *arg, unsigned long max, unsigned *value) {
+    assert(value != NULL);
+
+    // strtoul by přijal i znaménko a úvodní mezery
+    if (arg == NULL || !isdigit((unsigned char)arg[0])) { return false; }
+
+    char *end;
+    errno = 0;
+    unsigned long number = strtoul(arg, &end, 10);
+    if (errno != 0 || *end != '\0' || number > max) { return false; }
+
+    *value = (unsigned)number;
+    return true;
+}
+
 /********************************************
 **                                         **
 **       Literály, klauzule a formule      **
@@ -19,7 +46,7 @@ void error(char* error_msg) {
 
 
 struct Literal {
-    int var;
+    int64_t var;
     struct Literal *next_literal;
 };
 
@@ -37,7 +64,8 @@ struct CNF {
     Clause* first_clause;
     Clause* last_clause;
 
-    unsigned num_of_clauses;
+    uint64_t num_of_clauses;
+    uint64_t num_of_aux_variables;
     unsigned num_of_regions;
     unsigned num_of_products;
 };
@@ -76,6 +104,27 @@ Clause* create_new_clause(CNF* formula) {
     return new_clause;
 }
 
+/** Funkce připojí literál na konec klauzule
+* @param clause klauzule
+* @param new_literal alokovaný literál
+* @param lit_num index proměnné, záporný pro negativní literál
+*/
+void append_literal(Clause *clause, Literal *new_literal, int64_t lit_num) {
+    assert(clause != NULL);
+    assert(new_literal != NULL);
+
+    new_literal->var = lit_num;
+    new_literal->next_literal = NULL;
+
+    if (clause->last_literal == NULL) {
+        assert(clause->first_literal == NULL);
+        clause->first_literal = new_literal;
+    } else {
+        clause->last_literal->next_literal = new_literal;
+    }
+    clause->last_literal = new_literal;
+}
+
 /** Funkce přidá literál do klauzule. Literál je pozitivní nebo negativní
 * výroková proměnná.
 * @param clause klauzule
@@ -100,44 +149,176 @@ void add_literal_to_clause(Clause *clause, bool is_positive, bool is_main_produc
         error("Invalid product used.");
     }
 
-    // výpočet indexu proměnné
-    int lit_num = num_of_products * region + product + 1;
+    // výpočet indexu proměnné (v 64 bitech, součin K * P nemusí
+    // vyjít v rozsahu typu unsigned)
+    int64_t lit_num = (int64_t)num_of_products * region + product + 1;
 
     // indexy vedlejších proměnných jsou odsazeny o hodnotu K * P
-    if (!is_main_product) { lit_num += num_of_products * num_of_regions; }
+    if (!is_main_product) { lit_num += (int64_t)num_of_products * num_of_regions; }
 
     // negativní proměnné jsou vyjádřeny pomocí záporného čísla
     if (!is_positive) {
         lit_num = -lit_num;
     }
-    new_literal->var = lit_num;
-    new_literal->next_literal = NULL;
+    append_literal(clause, new_literal, lit_num);
+}
 
-    if (clause->last_literal == NULL) {
-        assert(clause->first_literal == NULL);
-        clause->first_literal = new_literal;
-    } else {
-        clause->last_literal->next_literal = new_literal;
+/** Funkce vytvoří novou pomocnou proměnnou. Pomocné proměnné mají indexy
+* za všemi proměnnými h_{k,p} a v_{k,p}.
+* @param formula výroková formule
+* @return číslo pomocné proměnné (číslováno od 1)
+*/
+uint64_t new_aux_variable(CNF *formula) {
+    assert(formula != NULL);
+    return ++formula->num_of_aux_variables;
+}
+
+/** Funkce přidá do klauzule literál pomocné proměnné.
+* @param clause klauzule
+* @param is_positive příznak udávající, zda je proměnná pozitivní
+* @param aux číslo pomocné proměnné vrácené funkcí new_aux_variable
+*/
+void add_aux_literal_to_clause(Clause *clause, bool is_positive, uint64_t aux) {
+    assert(clause != NULL);
+    assert(aux > 0);
+
+    Literal *new_literal = malloc(sizeof(Literal));
+
+    // pomocné proměnné jsou odsazeny o hodnotu 2 * K * P
+    int64_t lit_num = 2 * (int64_t)clause->num_of_products * clause->num_of_regions + (int64_t)aux;
+    if (!is_positive) {
+        lit_num = -lit_num;
     }
-    clause->last_literal = new_literal;
+    append_literal(clause, new_literal, lit_num);
 }
 
 /** Funkce vrátí počet proměnných výrokové formule
 * @param formula výroková formule
 */
-unsigned get_num_of_variables(CNF* formula) {
+uint64_t get_num_of_variables(CNF* formula) {
     assert(formula != NULL);
-    return 2 * formula->num_of_products * formula->num_of_regions;
+    return 2 * (uint64_t)formula->num_of_products * formula->num_of_regions + formula->num_of_aux_variables;
 }
 
 /** Funkce vrátí počet klauzulí výrokové formule
 * @param formula výroková formule
 */
-unsigned get_num_of_clauses(CNF* formula) {
+uint64_t get_num_of_clauses(CNF* formula) {
     assert(formula != NULL);
     return formula->num_of_clauses;
 }
 
+/** Generátor pseudonáhodných čísel splitmix64
+* @param state stav generátoru, funkce jej posune
+* @return další pseudonáhodné číslo
+*/
+uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+/** Funkce náhodně promíchá pořadí klauzulí ve formuli. Pořadí klauzulí
+* ovlivňuje heuristiky SAT řešiče, různé varianty formule se tak
+* v portfoliu chovají různě. Pro stejné semínko je výsledek vždy stejný.
+* @param formula výroková formule
+* @param seed semínko generátoru pseudonáhodných čísel
+*/
+void shuffle_clauses(CNF* formula, uint64_t seed) {
+    assert(formula != NULL);
+
+    if (formula->num_of_clauses < 2) { return; }
+
+    Clause **clauses = (Clause **)malloc(formula->num_of_clauses * sizeof(Clause *));
+    if (clauses == NULL) {
+        error("Internal error.\n");
+    }
+    uint64_t i = 0;
+    for (Clause *cl = formula->first_clause; cl != NULL; cl = cl->next_clause) {
+        clauses[i++] = cl;
+    }
+
+    // Fisher-Yates
+    uint64_t state = seed;
+    for (i = formula->num_of_clauses - 1; i > 0; --i) {
+        uint64_t j = next_random(&state) % (i + 1);
+        Clause *tmp = clauses[i];
+        clauses[i] = clauses[j];
+        clauses[j] = tmp;
+    }
+
+    // opětovné propojení klauzulí v novém pořadí
+    for (i = 0; i + 1 < formula->num_of_clauses; ++i) {
+        clauses[i]->next_clause = clauses[i + 1];
+    }
+    clauses[formula->num_of_clauses - 1]->next_clause = NULL;
+    formula->first_clause = clauses[0];
+    formula->last_clause = clauses[formula->num_of_clauses - 1];
+
+    free(clauses);
+}
+
+/** Funkce vytvoří náhodnou permutaci indexů proměnných 1, ..., n.
+* Pro stejné semínko je výsledek vždy stejný.
+* @param num_of_variables počet proměnných n
+* @param seed semínko generátoru pseudonáhodných čísel
+* @return pole délky n + 1, kde prvek i je nový index proměnné i (prvek 0 je 0)
+*/
+uint64_t *random_permutation(uint64_t num_of_variables, uint64_t seed) {
+    uint64_t *perm = (uint64_t *)malloc((num_of_variables + 1) * sizeof(uint64_t));
+    if (perm == NULL) {
+        error("Internal error.\n");
+    }
+    for (uint64_t i = 0; i <= num_of_variables; ++i) {
+        perm[i] = i;
+    }
+
+    // Fisher-Yates nad indexy 1, ..., n; semínko se odlišuje od semínka
+    // pro promíchání klauzulí, aby obě permutace nebyly svázané
+    uint64_t state = ~seed;
+    for (uint64_t i = num_of_variables; i > 1; --i) {
+        uint64_t j = 1 + next_random(&state) % i;
+        uint64_t tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+    return perm;
+}
+
+/** Funkce přečísluje proměnné ve všech literálech formule. Řešiče
+* (např. minisat) rozhodují mezi proměnnými se stejnou aktivitou podle
+* jejich indexu, přečíslování tak mění pořadí rozhodování.
+* @param formula výroková formule
+* @param perm permutace, prvek i je nový index proměnné i
+*/
+void permute_variables(CNF* formula, const uint64_t *perm) {
+    assert(formula != NULL);
+    assert(perm != NULL);
+
+    for (Clause *cl = formula->first_clause; cl != NULL; cl = cl->next_clause) {
+        for (Literal *lit = cl->first_literal; lit != NULL; lit = lit->next_literal) {
+            lit->var = lit->var < 0 ? -(int64_t)perm[-lit->var] : (int64_t)perm[lit->var];
+        }
+    }
+}
+
+/** Funkce vytiskne permutaci proměnných jako komentář formátu DIMACS
+* "c permutation <nový index proměnné 1> ... <nový index proměnné n>",
+* aby bylo možné model řešiče převést zpět na původní proměnné.
+* @param perm permutace, prvek i je nový index proměnné i
+* @param num_of_variables počet proměnných
+*/
+void print_permutation(const uint64_t *perm, uint64_t num_of_variables) {
+    assert(perm != NULL);
+
+    printf("c permutation");
+    for (uint64_t i = 1; i <= num_of_variables; ++i) {
+        printf(" %" PRIu64, perm[i]);
+    }
+    printf("\n");
+}
+
 /** Funkce uvolní paměť alokovanou pro uchování klauzule
 * @param cl klauzule
 */
@@ -164,20 +345,24 @@ void clear_cnf(CNF* formula) {
     }
     formula->last_clause = NULL;
     formula->num_of_clauses = 0;
+    formula->num_of_aux_variables = 0;
 }
 
-/** Funkce vytiskne vytvořenou formuli ve formátu DIMACS
+/** Funkce vytiskne všechny klauzule formule, každou na samostatný řádek
+* uvozený zadaným prefixem
 * @param formula výroková formule
+* @param prefix řetězec vypsaný na začátku každého řádku
 */
-void print_formula(CNF* formula) {
+void print_clauses(CNF* formula, const char *prefix) {
     assert(formula != NULL);
+    assert(prefix != NULL);
 
-    printf("p cnf %u %u\n", get_num_of_variables(formula), get_num_of_clauses(formula));
     Clause *next_cl = formula->first_clause;
     while (next_cl != 0) {
+        printf("%s", prefix);
         Literal *next_lit = next_cl->first_literal;
         while (next_lit != 0) {
-            printf("%d ", next_lit->var);
+            printf("%" PRId64 " ", next_lit->var);
             next_lit = next_lit->next_literal;
         }
         next_cl = next_cl->next_clause;
@@ -185,6 +370,154 @@ void print_formula(CNF* formula) {
     }
 }
 
+/** Funkce vytiskne vytvořenou formuli ve formátu DIMACS
+* @param formula výroková formule
+*/
+void print_formula(CNF* formula) {
+    assert(formula != NULL);
+
+    printf("p cnf %" PRIu64 " %" PRIu64 "\n", get_num_of_variables(formula), get_num_of_clauses(formula));
+    print_clauses(formula, "");
+}
+
+/** Funkce vytiskne formuli rozdělenou na kostky ve formátu iCNF
+* (inkrementální DIMACS). Za klauzulemi základní formule následuje
+* pro každou kostku řádek "a <literály> 0", který inkrementální řešič
+* řeší jako samostatný dotaz s danými předpoklady.
+* @param formula výroková formule
+* @param cubes kostky, každá uložená jako jedna klauzule
+*/
+void print_incremental_formula(CNF* formula, CNF* cubes) {
+    assert(formula != NULL);
+    assert(cubes != NULL);
+
+    printf("p inccnf\n");
+    print_clauses(formula, "");
+    print_clauses(cubes, "a ");
+}
+
+/********************************************
+**                                         **
+**        Binární formát formule           **
+**                                         **
+********************************************/
+
+/* Kompaktní binární formát formule:
+*   - hlavička: magická sekvence BCNF_MAGIC, počet proměnných a počet klauzulí
+*   - každá klauzule: počet literálů, následovaný literály
+* Všechna čísla jsou kódována jako varint (7 bitů na bajt, nejvyšší bit
+* značí pokračování). Literál l je převeden na kód 2 * |l| + (l < 0) a ukládá se
+* rozdíl vůči kódu předchozího literálu téže klauzule (u prvního vůči nule),
+* zakódovaný metodou zigzag, aby malé záporné rozdíly zabraly jeden bajt.
+* Formát neobsahuje komentáře. Slouží k úspornému uložení a přenosu formule,
+* řešiči se zatím předává až po převodu do DIMACS přepínačem --decode.
+*/
+#define BCNF_MAGIC "BCNF"
+#define BCNF_MAGIC_LENGTH 4
+
+/** Funkce zapíše nezáporné číslo ve formátu varint
+* @param out výstupní soubor
+* @param value zapisované číslo
+*/
+void write_varint(FILE *out, uint64_t value) {
+    while (value >= 0x80) {
+        fputc((int)(value & 0x7f) | 0x80, out);
+        value >>= 7;
+    }
+    fputc((int)value, out);
+}
+
+/** Funkce načte nezáporné číslo ve formátu varint
+* @param in vstupní soubor
+* @return načtené číslo
+*/
+uint64_t read_varint(FILE *in) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        int byte = fgetc(in);
+        if (byte == EOF) {
+            error("Unexpected end of the binary formula.\n");
+        }
+        if (shift == 63 && (byte & 0x7e)) {
+            error("Invalid number in the binary formula.\n");
+        }
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) { return value; }
+    }
+    error("Invalid number in the binary formula.\n");
+    return 0;
+}
+
+/** Funkce vytiskne vytvořenou formuli v kompaktním binárním formátu
+* @param formula výroková formule
+*/
+void print_formula_binary(CNF* formula) {
+    assert(formula != NULL);
+
+    fwrite(BCNF_MAGIC, 1, BCNF_MAGIC_LENGTH, stdout);
+    write_varint(stdout, get_num_of_variables(formula));
+    write_varint(stdout, get_num_of_clauses(formula));
+
+    Clause *next_cl = formula->first_clause;
+    while (next_cl != 0) {
+        uint64_t num_of_literals = 0;
+        for (Literal *lit = next_cl->first_literal; lit != 0; lit = lit->next_literal) {
+            ++num_of_literals;
+        }
+        write_varint(stdout, num_of_literals);
+
+        uint64_t prev_code = 0;
+        for (Literal *lit = next_cl->first_literal; lit != 0; lit = lit->next_literal) {
+            uint64_t code = lit->var < 0 ? 2 * (uint64_t)(-lit->var) + 1 : 2 * (uint64_t)lit->var;
+            // rozdíl se počítá modulo 2^64, zigzag jej převede na malé nezáporné číslo
+            uint64_t delta = code - prev_code;
+            write_varint(stdout, (delta << 1) ^ ((delta >> 63) ? UINT64_MAX : 0));
+            prev_code = code;
+        }
+        next_cl = next_cl->next_clause;
+    }
+}
+
+/** Funkce načte formuli v kompaktním binárním formátu a vytiskne ji
+* ve formátu DIMACS
+* @param in vstupní soubor s binární formulí
+*/
+void decode_binary_formula(FILE *in) {
+    assert(in != NULL);
+
+    char magic[BCNF_MAGIC_LENGTH];
+    if (fread(magic, 1, BCNF_MAGIC_LENGTH, in) != BCNF_MAGIC_LENGTH || memcmp(magic, BCNF_MAGIC, BCNF_MAGIC_LENGTH) != 0) {
+        error("The input file is not a binary formula.\n");
+    }
+
+    uint64_t num_of_variables = read_varint(in);
+    uint64_t num_of_clauses = read_varint(in);
+    if (num_of_variables > INT64_MAX) {
+        error("The number of variables is too high.\n");
+    }
+
+    printf("p cnf %" PRIu64 " %" PRIu64 "\n", num_of_variables, num_of_clauses);
+    for (uint64_t c = 0; c < num_of_clauses; ++c) {
+        uint64_t num_of_literals = read_varint(in);
+        uint64_t prev_code = 0;
+        for (uint64_t l = 0; l < num_of_literals; ++l) {
+            uint64_t zigzag = read_varint(in);
+            uint64_t code = prev_code + ((zigzag >> 1) ^ ((zigzag & 1) ? UINT64_MAX : 0));
+            uint64_t var = code >> 1;
+            if (var == 0 || var > num_of_variables) {
+                error("Invalid variable in the binary formula.\n");
+            }
+            printf("%s%" PRIu64 " ", (code & 1) ? "-" : "", var);
+            prev_code = code;
+        }
+        printf("0\n");
+    }
+
+    if (fgetc(in) != EOF) {
+        error("Unexpected data after the end of the binary formula.\n");
+    }
+}
+
 /*******************************
 **                            **
 **       Seznamy sousedů      **
@@ -296,19 +629,488 @@ bool are_neighbours(const NeighbourLists *lists, unsigned fst, unsigned snd) {
     return false;
 }
 
+/*******************************
+**                            **
+**    Dopředné vyhledávání    **
+**                            **
+********************************/
+
+/** Počet regionů s nejvyšším stupněm, mezi nimiž dopředné vyhledávání
+* vybírá region pro další dělení kostky
+*/
+#define LOOKAHEAD_CANDIDATES 8
+
+/** Struktura uchovává formuli v podobě vhodné pro propagaci jednotkových
+* klauzulí a aktuální částečné ohodnocení proměnných. Každá klauzule si
+* pamatuje počet svých nepravdivých literálů, klauzule s jediným
+* nenepravdivým literálem je tak nalezena bez procházení celé formule.
+*/
+typedef struct Propagator {
+    uint64_t num_of_variables; /**< počet proměnných formule */
+    uint64_t num_of_clauses; /**< počet klauzulí formule */
+    uint64_t *clause_start; /**< začátky klauzulí v poli literals */
+    int64_t *literals; /**< literály všech klauzulí uložené za sebou */
+    uint64_t *num_of_false; /**< počet nepravdivých literálů každé klauzule */
+    uint64_t *occurrence_start; /**< začátky seznamů výskytů v poli occurrences */
+    uint64_t *occurrences; /**< indexy klauzulí obsahujících daný literál */
+    signed char *values; /**< ohodnocení proměnných: 1, -1 nebo 0 (neohodnoceno) */
+    int64_t *trail; /**< pravdivé literály v pořadí jejich ohodnocení */
+    uint64_t trail_size; /**< počet literálů v poli trail */
+    uint64_t num_of_propagated; /**< počet literálů z trail, jejichž důsledky jsou započteny */
+    bool conflict; /**< příznak sporu */
+} Propagator;
+
+/** Funkce vrátí kód literálu 2 * |l| + (l < 0) sloužící jako index
+* do seznamů výskytů
+* @param lit literál
+*/
+uint64_t literal_code(int64_t lit) {
+    return lit < 0 ? 2 * (uint64_t)(-lit) + 1 : 2 * (uint64_t)lit;
+}
+
+/** Funkce vrátí hodnotu literálu v aktuálním ohodnocení
+* @param prop propagátor
+* @param lit literál
+* @return 1 (pravdivý), -1 (nepravdivý) nebo 0 (neohodnocený)
+*/
+int literal_value(const Propagator *prop, int64_t lit) {
+    int value = prop->values[lit < 0 ? -lit : lit];
+    return lit < 0 ? -value : value;
+}
+
+/** Funkce ohodnotí literál jako pravdivý. Je-li literál již nepravdivý,
+* nastaví příznak sporu.
+* @param prop propagátor
+* @param lit literál
+*/
+void assign_literal(Propagator *prop, int64_t lit) {
+    int value = literal_value(prop, lit);
+    if (value != 0) {
+        if (value < 0) { prop->conflict = true; }
+        return;
+    }
+    prop->values[lit < 0 ? -lit : lit] = lit < 0 ? -1 : 1;
+    prop->trail[prop->trail_size++] = lit;
+}
+
+/** Funkce provede propagaci jednotkových klauzulí, dokud nejsou započteny
+* důsledky všech ohodnocených literálů nebo nenastane spor.
+* @param prop propagátor
+*/
+void propagate(Propagator *prop) {
+    while (!prop->conflict && prop->num_of_propagated < prop->trail_size) {
+        uint64_t code = literal_code(-prop->trail[prop->num_of_propagated++]);
+        uint64_t first = prop->occurrence_start[code];
+        uint64_t last = prop->occurrence_start[code + 1];
+
+        // počty nepravdivých literálů se navyšují vždy všechny, aby šlo
+        // ohodnocení korektně vrátit i po sporu
+        for (uint64_t o = first; o < last; ++o) {
+            ++prop->num_of_false[prop->occurrences[o]];
+        }
+
+        for (uint64_t o = first; o < last && !prop->conflict; ++o) {
+            uint64_t c = prop->occurrences[o];
+            uint64_t length = prop->clause_start[c + 1] - prop->clause_start[c];
+            if (prop->num_of_false[c] + 1 < length) { continue; }
+
+            // klauzule je splněná, jednotková, nebo ve sporu
+            int64_t unassigned = 0;
+            bool satisfied = false;
+            for (uint64_t l = prop->clause_start[c]; l < prop->clause_start[c + 1]; ++l) {
+                int value = literal_value(prop, prop->literals[l]);
+                if (value > 0) { satisfied = true; break; }
+                if (value == 0) { unassigned = prop->literals[l]; }
+            }
+            if (satisfied) { continue; }
+            if (unassigned == 0) {
+                prop->conflict = true;
+            } else {
+                assign_literal(prop, unassigned);
+            }
+        }
+    }
+}
+
+/** Funkce vrátí ohodnocení do stavu, kdy obsahovalo daný počet literálů,
+* a zruší příznak sporu.
+* @param prop propagátor
+* @param trail_size počet literálů, které v ohodnocení zůstanou
+*/
+void backtrack(Propagator *prop, uint64_t trail_size) {
+    while (prop->num_of_propagated > trail_size) {
+        uint64_t code = literal_code(-prop->trail[--prop->num_of_propagated]);
+        for (uint64_t o = prop->occurrence_start[code]; o < prop->occurrence_start[code + 1]; ++o) {
+            --prop->num_of_false[prop->occurrences[o]];
+        }
+    }
+    while (prop->trail_size > trail_size) {
+        int64_t lit = prop->trail[--prop->trail_size];
+        prop->values[lit < 0 ? -lit : lit] = 0;
+    }
+    prop->conflict = false;
+}
+
+/** Funkce sestaví propagátor pro danou formuli a propaguje její jednotkové
+* klauzule. Obsahuje-li formule prázdnou klauzuli, je nastaven příznak sporu.
+* @param prop propagátor
+* @param formula výroková formule
+*/
+void init_propagator(Propagator *prop, CNF *formula) {
+    assert(prop != NULL);
+    assert(formula != NULL);
+
+    prop->num_of_variables = get_num_of_variables(formula);
+    prop->num_of_clauses = get_num_of_clauses(formula);
+
+    uint64_t num_of_literals = 0;
+    for (Clause *cl = formula->first_clause; cl != NULL; cl = cl->next_clause) {
+        for (Literal *lit = cl->first_literal; lit != NULL; lit = lit->next_literal) {
+            ++num_of_literals;
+        }
+    }
+
+    uint64_t num_of_codes = 2 * (prop->num_of_variables + 1);
+    prop->clause_start = (uint64_t *)malloc((prop->num_of_clauses + 1) * sizeof(uint64_t));
+    prop->literals = (int64_t *)malloc((num_of_literals + 1) * sizeof(int64_t));
+    prop->num_of_false = (uint64_t *)calloc(prop->num_of_clauses + 1, sizeof(uint64_t));
+    prop->occurrence_start = (uint64_t *)calloc(num_of_codes + 1, sizeof(uint64_t));
+    prop->occurrences = (uint64_t *)malloc((num_of_literals + 1) * sizeof(uint64_t));
+    prop->values = (signed char *)calloc(prop->num_of_variables + 1, sizeof(signed char));
+    prop->trail = (int64_t *)malloc((prop->num_of_variables + 1) * sizeof(int64_t));
+    uint64_t *cursor = (uint64_t *)malloc(num_of_codes * sizeof(uint64_t));
+    if (prop->clause_start == NULL || prop->literals == NULL || prop->num_of_false == NULL
+        || prop->occurrence_start == NULL || prop->occurrences == NULL || prop->values == NULL
+        || prop->trail == NULL || cursor == NULL) {
+        error("Internal error.\n");
+    }
+
+    // uložení klauzulí za sebou a spočtení výskytů literálů
+    uint64_t c = 0, l = 0;
+    for (Clause *cl = formula->first_clause; cl != NULL; cl = cl->next_clause, ++c) {
+        prop->clause_start[c] = l;
+        for (Literal *lit = cl->first_literal; lit != NULL; lit = lit->next_literal, ++l) {
+            prop->literals[l] = lit->var;
+            ++prop->occurrence_start[literal_code(lit->var) + 1];
+        }
+    }
+    prop->clause_start[c] = l;
+
+    // seznamy výskytů literálů
+    for (uint64_t i = 0; i < num_of_codes; ++i) {
+        prop->occurrence_start[i + 1] += prop->occurrence_start[i];
+        cursor[i] = prop->occurrence_start[i];
+    }
+    for (c = 0; c < prop->num_of_clauses; ++c) {
+        for (l = prop->clause_start[c]; l < prop->clause_start[c + 1]; ++l) {
+            prop->occurrences[cursor[literal_code(prop->literals[l])]++] = c;
+        }
+    }
+    free(cursor);
+
+    // propagace prázdných a jednotkových klauzulí
+    prop->trail_size = 0;
+    prop->num_of_propagated = 0;
+    prop->conflict = false;
+    for (c = 0; c < prop->num_of_clauses; ++c) {
+        uint64_t length = prop->clause_start[c + 1] - prop->clause_start[c];
+        if (length == 0) { prop->conflict = true; }
+        if (length == 1) { assign_literal(prop, prop->literals[prop->clause_start[c]]); }
+    }
+    propagate(prop);
+}
+
+/** Uvolnění paměti alokované propagátorem
+* @param prop propagátor
+*/
+void clear_propagator(Propagator *prop) {
+    assert(prop != NULL);
+    free(prop->clause_start);
+    free(prop->literals);
+    free(prop->num_of_false);
+    free(prop->occurrence_start);
+    free(prop->occurrences);
+    free(prop->values);
+    free(prop->trail);
+}
+
+/** Funkce zjistí, kolik proměnných propagace ohodnotí po přidání literálu
+* do aktuálního ohodnocení. Ohodnocení zůstane po návratu nezměněno.
+* @param prop propagátor
+* @param lit zkoumaný literál
+* @return počet nově ohodnocených proměnných, nebo UINT64_MAX při sporu
+*/
+uint64_t probe_literal(Propagator *prop, int64_t lit) {
+    uint64_t trail_size = prop->trail_size;
+    assign_literal(prop, lit);
+    propagate(prop);
+    uint64_t result = prop->conflict ? UINT64_MAX : prop->trail_size - trail_size;
+    backtrack(prop, trail_size);
+    return result;
+}
+
+/*******************************
+**                            **
+**     Rozdělení na kostky    **
+**                            **
+********************************/
+
+/** Největší povolený požadovaný počet kostek */
+#define MAX_NUM_OF_CUBES 1000000
+#define MAX_NUM_OF_CUBES_STR "1000000"
+
+/** Struktura uchovává region a jeho stupeň (počet sousedů). Slouží
+* k uspořádání regionů, podle nichž se formule dělí na kostky.
+*/
+typedef struct RegionDegree {
+    unsigned region; /**< index regionu */
+    unsigned degree; /**< počet sousedů regionu */
+} RegionDegree;
+
+/** Porovnávací funkce pro qsort řadící regiony sestupně podle stupně,
+* regiony se stejným stupněm zůstávají seřazeny podle indexu.
+*/
+int compare_region_degrees(const void *fst, const void *snd) {
+    const RegionDegree *a = fst;
+    const RegionDegree *b = snd;
+    if (a->degree != b->degree) { return a->degree > b->degree ? -1 : 1; }
+    return (a->region > b->region) - (a->region < b->region);
+}
+
+/** Funkce rozdělí prostor řešení na kostky (cube-and-conquer). Kostka je
+* konjunkce literálů h_{k,p}, která přiřazuje hlavní produkt několika
+* regionům. Dělení probíhá po úrovních: každá kostka je rozdělena podle
+* hlavního produktu jednoho dosud nerozhodnutého regionu, dokud počet
+* kostek nedosáhne požadované hodnoty nebo nejsou rozhodnuty všechny regiony.
+*
+* Jako první se dělí podle regionu 0. Další region pro danou kostku vybírá
+* dopředné vyhledávání (lookahead) mezi LOOKAHEAD_CANDIDATES nerozhodnutými
+* regiony s nejvyšším počtem sousedů: pro každý produkt p je h_{k,p}
+* přidáno k literálům kostky a propagací jednotkových klauzulí je zjištěn
+* počet nově ohodnocených proměnných. Vybrán je region s nejvyšším součtem,
+* větev končící sporem se počítá jako ohodnocení všech proměnných.
+* Větve vedoucí ke sporu jsou rovnou vynechány, zbylé kostky tak dohromady
+* pokrývají všechna řešení formule.
+* @param cubes formule, do níž je každá kostka přidána jako jedna klauzule
+* @param formula výroková formule, která je dělena
+* @param neighbours seznamy sousedů
+* @param num_of_products počet produktů
+* @param min_num_of_cubes požadovaný minimální počet kostek
+* @return true, pokud propagace vyvrátila všechny kostky, tj. formule
+* je nesplnitelná; kostky pak obsahují jedinou prázdnou kostku
+*/
+bool split_into_cubes(CNF *cubes, CNF *formula, const NeighbourLists *neighbours, unsigned num_of_products, unsigned min_num_of_cubes) {
+    assert(cubes != NULL);
+    assert(formula != NULL);
+    assert(neighbours != NULL);
+    assert(num_of_products > 0);
+
+    unsigned num_of_regions = neighbours->size;
+
+    // uspořádání regionů: region 0 první, ostatní sestupně podle stupně
+    RegionDegree *order = (RegionDegree *)malloc(num_of_regions * sizeof(RegionDegree));
+    uint64_t *probes = (uint64_t *)malloc(num_of_products * sizeof(uint64_t));
+    uint64_t *best_probes = (uint64_t *)malloc(num_of_products * sizeof(uint64_t));
+    if (order == NULL || probes == NULL || best_probes == NULL) {
+        error("Internal error.\n");
+    }
+    for (unsigned i = 0; i < num_of_regions; ++i) {
+        order[i].region = i;
+        order[i].degree = neighbours->data[i].size;
+    }
+    qsort(order + 1, num_of_regions - 1, sizeof(RegionDegree), compare_region_degrees);
+
+    Propagator prop;
+    init_propagator(&prop, formula);
+    uint64_t root_size = prop.trail_size;
+
+    // kostky dané úrovně jsou uloženy za sebou s roztečí depth, každá
+    // obsahuje level_length[c] indexů proměnných h_{k,p}
+    int64_t *level = (int64_t *)calloc(1, sizeof(int64_t));
+    unsigned *level_length = (unsigned *)calloc(1, sizeof(unsigned));
+    if (level == NULL || level_length == NULL) {
+        error("Internal error.\n");
+    }
+    size_t level_size = prop.conflict ? 0 : 1;
+    unsigned depth = 0;
+    bool split = true;
+
+    while (split && level_size > 0 && level_size < min_num_of_cubes && depth < num_of_regions) {
+        int64_t *next_level = (int64_t *)malloc(level_size * num_of_products * (depth + 1) * sizeof(int64_t));
+        unsigned *next_length = (unsigned *)malloc(level_size * num_of_products * sizeof(unsigned));
+        if (next_level == NULL || next_length == NULL) {
+            error("Internal error.\n");
+        }
+
+        size_t next_size = 0;
+        split = false;
+        for (size_t c = 0; c < level_size; ++c) {
+            int64_t *cube = level + c * depth;
+
+            // ohodnocení literálů kostky, kostky ve sporu jsou vynechány
+            for (unsigned j = 0; j < level_length[c]; ++j) {
+                assign_literal(&prop, cube[j]);
+            }
+            propagate(&prop);
+            if (prop.conflict) {
+                backtrack(&prop, root_size);
+                continue;
+            }
+
+            // výběr regionu pro dělení dopředným vyhledáváním
+            bool found = false;
+            uint64_t best_score = 0;
+            unsigned best_region = 0;
+            unsigned num_of_candidates = 0;
+            for (unsigned j = 0; j < num_of_regions && num_of_candidates < LOOKAHEAD_CANDIDATES; ++j) {
+                unsigned region = order[j].region;
+                // index proměnné h_{k,0}, viz add_literal_to_clause
+                int64_t first_var = (int64_t)num_of_products * region + 1;
+
+                bool decided = false;
+                for (unsigned p = 0; p < num_of_products && !decided; ++p) {
+                    decided = literal_value(&prop, first_var + p) > 0;
+                }
+                if (decided) { continue; }
+                ++num_of_candidates;
+
+                uint64_t score = 0;
+                for (unsigned p = 0; p < num_of_products; ++p) {
+                    probes[p] = literal_value(&prop, first_var + p) < 0 ? UINT64_MAX : probe_literal(&prop, first_var + p);
+                    score += probes[p] == UINT64_MAX ? prop.num_of_variables : probes[p] + 1;
+                }
+                if (!found || score > best_score) {
+                    found = true;
+                    best_score = score;
+                    best_region = region;
+                    for (unsigned p = 0; p < num_of_products; ++p) {
+                        best_probes[p] = probes[p];
+                    }
+                }
+
+                // region 0 je dělen přednostně
+                if (region == 0) { break; }
+            }
+            backtrack(&prop, root_size);
+
+            // kostka, v níž jsou rozhodnuty všechny regiony, se již nedělí
+            if (!found) {
+                for (unsigned j = 0; j < level_length[c]; ++j) {
+                    next_level[next_size * (depth + 1) + j] = cube[j];
+                }
+                next_length[next_size++] = level_length[c];
+                continue;
+            }
+
+            split = true;
+            for (unsigned p = 0; p < num_of_products; ++p) {
+                if (best_probes[p] == UINT64_MAX) { continue; }
+                int64_t *next_cube = next_level + next_size * (depth + 1);
+                for (unsigned j = 0; j < level_length[c]; ++j) {
+                    next_cube[j] = cube[j];
+                }
+                next_cube[level_length[c]] = (int64_t)num_of_products * best_region + p + 1;
+                next_length[next_size++] = level_length[c] + 1;
+            }
+        }
+
+        free(level);
+        free(level_length);
+        level = next_level;
+        level_length = next_length;
+        level_size = next_size;
+        ++depth;
+    }
+
+    // převod kostek na klauzule složené z pozitivních literálů h_{k,p}
+    for (size_t c = 0; c < level_size; ++c) {
+        if (level_length[c] == 0) { continue; }
+        Clause *cl = create_new_clause(cubes);
+        for (unsigned j = 0; j < level_length[c]; ++j) {
+            uint64_t var = (uint64_t)level[c * depth + j] - 1;
+            add_literal_to_clause(cl, true, MAIN_PRODUCT, (unsigned)(var / num_of_products), (unsigned)(var % num_of_products));
+        }
+    }
+
+    // pokud žádná kostka nezbyla (formule je nesplnitelná) nebo nebylo třeba
+    // dělit, je vytvořena jediná prázdná kostka odpovídající celé formuli
+    bool refuted = level_size == 0;
+    if (cubes->num_of_clauses == 0) {
+        create_new_clause(cubes);
+    }
+
+    clear_propagator(&prop);
+    free(level);
+    free(level_length);
+    free(probes);
+    free(best_probes);
+    free(order);
+    return refuted;
+}
+
 int main (int argc, char** argv) {
 
     // program musí být spuštěn s jediným argumentem odpovídajícím
-    // názvu souboru v korektním formátu
-    if (argc != 2) {
+    // názvu souboru v korektním formátu, kterému mohou předcházet přepínače
+    //   --cubes N  rozdělení formule na alespoň N kostek
+    //   --binary   výpis formule v kompaktním binárním formátu
+    //   --decode   vstupní soubor je binární formule, která je vypsána ve formátu DIMACS
+    //   --variant K  výběr varianty formule pro portfolio řešičů, kde
+    //              bit 0 zapíná sekvenční kódování podmínek "nejvýše jeden",
+    //              bit 1 zapíná lámání symetrie produktů,
+    //              bit 2 zapíná náhodné přečíslování proměnných a
+    //              zbylé bity (K >> 3) jsou semínkem pro přečíslování proměnných
+    //              a pro promíchání klauzulí (0 = nemíchat)
+    const char *input_name = NULL;
+    unsigned num_of_cubes = 0;
+    unsigned variant = 0;
+    bool binary_output = false;
+    bool decode_input = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            binary_output = true;
+        } else if (strcmp(argv[i], "--decode") == 0) {
+            decode_input = true;
+        } else if (strcmp(argv[i], "--variant") == 0) {
+            if (i + 1 >= argc || !parse_number(argv[++i], UINT_MAX, &variant)) {
+                error("The option --variant expects a non-negative number.\n");
+            }
+        } else if (strcmp(argv[i], "--cubes") == 0) {
+            if (i + 1 >= argc || !parse_number(argv[++i], MAX_NUM_OF_CUBES, &num_of_cubes) || num_of_cubes == 0) {
+                error("The option --cubes expects a number of cubes between 1 and " MAX_NUM_OF_CUBES_STR ".\n");
+            }
+        } else if (input_name == NULL) {
+            input_name = argv[i];
+        } else {
+            error("Exactly one argument is expected. Please type the name of an input file.\n");
+        }
+    }
+    if (input_name == NULL) {
         error("Exactly one argument is expected. Please type the name of an input file.\n");
     }
+    if (binary_output && num_of_cubes > 0) {
+        error("The options --binary and --cubes cannot be combined.\n");
+    }
+    // binární formát nemá komentáře, permutaci proměnných by nebylo kam uložit
+    if (binary_output && (variant & 4)) {
+        error("The option --binary cannot be combined with a variant permuting variables.\n");
+    }
+    if (decode_input && (binary_output || num_of_cubes > 0 || variant > 0)) {
+        error("The option --decode cannot be combined with other options.\n");
+    }
 
-    FILE *input_file = fopen(argv[1], "r");
+    FILE *input_file = fopen(input_name, decode_input ? "rb" : "r");
     if (input_file == NULL) {
         error("The input file could not be opened.\n");
     }
 
+    // převod binární formule do formátu DIMACS
+    if (decode_input) {
+        decode_binary_formula(input_file);
+        fclose(input_file);
+        return 0;
+    }
+
     // načtení hlavičky vstupního souboru
     unsigned num_of_regions, num_of_products;
     if (fscanf(input_file, "%u %u", &num_of_regions, &num_of_products) != 2) {
@@ -328,6 +1130,13 @@ int main (int argc, char** argv) {
         error("The number of products has to be positive.\n");
     }
 
+    // indexy všech 2 * K * P proměnných a nejvýše stejného počtu pomocných
+    // proměnných musí být zobrazitelné v typu int64_t
+    if ((uint64_t)num_of_regions * num_of_products > INT64_MAX / 4) {
+        fclose(input_file);
+        error("The number of variables is too high.\n");
+    }
+
     // inicializace seznamu sousedů
     NeighbourLists neighbours = {.size = num_of_regions, .data = NULL};
     neighbours.data = (NeighbourList *)malloc(num_of_regions * sizeof(NeighbourList));
@@ -355,24 +1164,66 @@ int main (int argc, char** argv) {
     }
 
     // inicializace výsledné formule
-    CNF f = { .first_clause = NULL, .last_clause = NULL, .num_of_clauses = 0, .num_of_regions = num_of_regions, .num_of_products = num_of_products };
+    CNF f = { .first_clause = NULL, .last_clause = NULL, .num_of_clauses = 0, .num_of_aux_variables = 0, .num_of_regions = num_of_regions, .num_of_products = num_of_products };
 
     // konstrukce klauzulí
     all_regions_min_one_main_product(&f, num_of_regions, num_of_products);
-    all_regions_max_one_main_product(&f, num_of_regions, num_of_products);
-    all_regions_max_one_side_product(&f, num_of_regions, num_of_products);
+    if (variant & 1) {
+        all_regions_max_one_main_product_sequential(&f, num_of_regions, num_of_products);
+        all_regions_max_one_side_product_sequential(&f, num_of_regions, num_of_products);
+    } else {
+        all_regions_max_one_main_product(&f, num_of_regions, num_of_products);
+        all_regions_max_one_side_product(&f, num_of_regions, num_of_products);
+    }
     main_side_products_different(&f, num_of_regions, num_of_products);
     neighbour_regions_different_main_products(&f, num_of_regions, num_of_products, &neighbours);
     all_products_at_least_once_main_products(&f, num_of_regions, num_of_products);
     no_side_product_in_main_region(&f, num_of_regions, num_of_products);
     main_region_main_product_as_side_product_elsewhere(&f, num_of_regions, num_of_products);
+    if (variant & 2) {
+        break_product_symmetry(&f, num_of_regions, num_of_products);
+    }
+    if (variant >> 3) {
+        shuffle_clauses(&f, variant >> 3);
+    }
+
+    // rozdělení na kostky probíhá nad původními indexy proměnných
+    CNF cubes = { .first_clause = NULL, .last_clause = NULL, .num_of_clauses = 0, .num_of_aux_variables = 0, .num_of_regions = num_of_regions, .num_of_products = num_of_products };
+    if (num_of_cubes > 0) {
+        // nesplnitelnost dokázaná dopředným vyhledáváním je zachována
+        // prázdnou klauzulí, řešič tak formuli nemusí řešit znovu celou
+        if (split_into_cubes(&cubes, &f, &neighbours, num_of_products, num_of_cubes)) {
+            create_new_clause(&f);
+        }
+    }
+
+    // přečíslování proměnných formule i kostek
+    uint64_t *perm = NULL;
+    if (variant & 4) {
+        perm = random_permutation(get_num_of_variables(&f), variant >> 3);
+        permute_variables(&f, perm);
+        permute_variables(&cubes, perm);
+    }
 
     // výpis formule
-    printf("c Formula:\n");
-    print_formula(&f);
+    if (binary_output) {
+        print_formula_binary(&f);
+    } else {
+        printf("c Formula:\n");
+        if (perm != NULL) {
+            print_permutation(perm, get_num_of_variables(&f));
+        }
+        if (num_of_cubes > 0) {
+            print_incremental_formula(&f, &cubes);
+        } else {
+            print_formula(&f);
+        }
+    }
 
     // uvolnění alokované paměti
+    free(perm);
     clear_neighbours(&neighbours);
+    clear_cnf(&cubes);
     clear_cnf(&f);
 
     return 0;
@@ -1,3 +1,3 @@
 #!/usr/bin/env sh
 
-python3 ../tests/run.py $1
+python3 ../tests/run.py "$@"
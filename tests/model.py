@@ -181,10 +181,14 @@ class Model:
         if self.status == STATUS_UNSAT:
             return
 
-        minisat_model = " ".join([str(literal) for literal in self.literals])
+        # auxiliary variables of some formula variants are not part of the problem
+        num_of_problem_variables = 2 * self.input.num_of_products * self.input.num_of_regions
+        literals = [literal for literal in self.literals if abs(literal) <= num_of_problem_variables]
+
+        minisat_model = " ".join([str(literal) for literal in literals])
 
         human_readable_model = ""
-        for literal in self.literals:
+        for literal in literals:
 
             num_of_products = self.input.num_of_products
             num_of_regions = self.input.num_of_regions
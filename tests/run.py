@@ -1,20 +1,35 @@
 #!/usr/bin/env python3
 
-import sys
+import argparse
 
 from model import ModelError
-from run_tests import execute, smoke_test, print_ok, print_err, SolverError, GeneratorError
+from run_tests import execute, execute_cubes, execute_portfolio, smoke_test, print_ok, print_err, SolverError, GeneratorError
+
+
+def positive(value):
+    if not value.isdigit() or int(value) == 0:
+        raise argparse.ArgumentTypeError(f"{value} is not a positive number")
+    return int(value)
 
 
 if __name__ == "__main__":
-    if len(sys.argv) != 2:
-        print("Usage: ./run.py input")
-        exit(1)
+    parser = argparse.ArgumentParser(usage="./run.py [--portfolio N | --cubes N [--workers W]] input")
+    parser.add_argument("input")
+    modes = parser.add_mutually_exclusive_group()
+    modes.add_argument("--portfolio", type=positive, metavar="N", help="race N variants of the formula")
+    modes.add_argument("--cubes", type=positive, metavar="N", help="split the formula into at least N cubes")
+    parser.add_argument("--workers", type=positive, default=4, metavar="W", help="number of solvers solving cubes in parallel")
+    args = parser.parse_args()
 
     smoke_test()
 
     try:
-        result = execute(sys.argv[1])
+        if args.portfolio:
+            result = execute_portfolio(args.input, args.portfolio)
+        elif args.cubes:
+            result = execute_cubes(args.input, args.cubes, args.workers, log=print)
+        else:
+            result = execute(args.input)
     except GeneratorError as e:
         print_err("Generator error:")
         print(e)
@@ -1,9 +1,16 @@
 #!/usr/bin/env python3
 
 import os
+import queue
+import re
+import shutil
+import threading
+import time
 
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from contextlib import ExitStack
 from tempfile import NamedTemporaryFile as TmpFile
-from subprocess import run, PIPE, TimeoutExpired
+from subprocess import run, Popen, PIPE, DEVNULL, TimeoutExpired
 
 from model import Model, Input, STATUS_SAT, STATUS_UNSAT, ModelError, InputError
 
@@ -13,6 +20,10 @@ SOLVER = "minisat"
 RC_SAT = 10
 RC_UNSAT = 20
 
+# sequential AMO, symmetry breaking, both, shuffled clauses (seed 1) and
+# sequential AMO with permuted variables and shuffled clauses (seed 1)
+TESTED_VARIANTS = [1, 2, 3, 8, 13]
+
 
 class colors:
     red = "\033[91m"
@@ -45,10 +56,37 @@ def smoke_test():
         exit(1)
 
 
-def execute(path):
+def load_permutation(dimacs_path):
+    """
+    Returns the inverse of the variable permutation stored by the translator
+    in the 'c permutation' comment (see the --variant option), or None.
+    """
+    with open(dimacs_path) as f:
+        for line in f:
+            if line.startswith("c permutation"):
+                perm = map(int, line.split()[2:])
+                return {new: old for (old, new) in enumerate(perm, start=1)}
+            if line.startswith("p"):
+                break
+    return None
+
+
+def load_model(model_path, dimacs_path, input):
+    """
+    Loads the solver model and maps permuted variables back to the
+    original ones, so that the model can be checked against the input.
+    """
+    model = Model.load(model_path, input)
+    inverse = load_permutation(dimacs_path)
+    if inverse is not None and model.literals:
+        model.literals = [inverse[abs(literal)] * (1 if literal > 0 else -1) for literal in model.literals]
+    return model
+
+
+def execute(path, variant=0):
     with TmpFile(mode="w+") as dimacs_out, TmpFile(mode="w+") as model_out:
         try:
-            translator = run([TRANSLATOR, path], stdout=dimacs_out, stderr=PIPE)
+            translator = run([TRANSLATOR, "--variant", str(variant), path], stdout=dimacs_out, stderr=PIPE)
         except Exception:
             raise GeneratorError("Error when running formula generator")
 
@@ -66,40 +104,301 @@ def execute(path):
             raise SolverError(solver.stderr.decode().strip())
 
         input = Input.load(path)
-        model = Model.load(model_out.name, input)
+        model = load_model(model_out.name, dimacs_out.name, input)
         return model
 
 
-def run_test_case(path, expected_status):
+def solver_options(worker):
+    # Worker 0 runs the solver with its default configuration, the others
+    # diversify with a small amount of seeded random decisions
+    if worker == 0:
+        return []
+    return ["-rnd-freq=0.02", f"-rnd-seed={worker}"]
+
+
+def portfolio_variant(worker):
+    # Worker 0 solves the unchanged formula. Every other worker cycles
+    # through the AMO encoding and symmetry breaking (bits 0 and 1) and
+    # always permutes the variables (bit 2) and shuffles the clauses with
+    # its own seed (K >> 3), see the --variant option of the translator
+    if worker == 0:
+        return 0
+    return (worker & 3) | 4 | (worker << 3)
+
+
+def execute_portfolio(path, num_of_workers):
+    """
+    Races num_of_workers solvers, each on its own variant of the formula
+    (see the --variant option of the translator). The first definitive
+    answer wins and the remaining solvers are terminated.
+    """
+    # every solver has its own waiter thread, which waits only for that
+    # solver and reports (worker, return code, stderr) to the queue
+    results = queue.Queue()
+
+    def wait_for_solver(worker, solver):
+        _, stderr = solver.communicate()
+        results.put((worker, solver.returncode, stderr))
+
+    with ExitStack() as stack:
+        workers = []
+        waiters = []
+        try:
+            for worker in range(num_of_workers):
+                dimacs_out = stack.enter_context(TmpFile(mode="w+"))
+                model_out = stack.enter_context(TmpFile(mode="w+"))
+                try:
+                    translator = run(
+                        [TRANSLATOR, "--variant", str(portfolio_variant(worker)), path],
+                        stdout=dimacs_out,
+                        stderr=PIPE,
+                    )
+                except Exception:
+                    raise GeneratorError("Error when running formula generator")
+
+                if translator.returncode != 0:
+                    raise GeneratorError(translator.stderr.decode().strip())
+
+                try:
+                    solver = Popen(
+                        [SOLVER, *solver_options(worker), dimacs_out.name, model_out.name],
+                        stdout=DEVNULL,
+                        stderr=PIPE,
+                    )
+                except Exception:
+                    raise SolverError("Error when running SAT solver")
+                workers.append((solver, dimacs_out, model_out))
+                waiter = threading.Thread(target=wait_for_solver, args=(worker, solver), daemon=True)
+                waiter.start()
+                waiters.append(waiter)
+
+            errors = []
+            for _ in workers:
+                worker, returncode, stderr = results.get()
+                if returncode in [RC_SAT, RC_UNSAT]:
+                    _, dimacs_out, model_out = workers[worker]
+                    input = Input.load(path)
+                    return load_model(model_out.name, dimacs_out.name, input)
+                errors.append(f"worker {worker}: {stderr.decode().strip()}")
+
+            raise SolverError("\n".join(errors))
+        finally:
+            for solver, _, _ in workers:
+                if solver.returncode is None:
+                    solver.terminate()
+            for waiter in waiters:
+                waiter.join()
+
+
+def parse_incremental_formula(text):
+    """
+    Splits the iCNF output of the translator (--cubes) into the base
+    clauses and the cubes. Both are kept as DIMACS lines ending with '0'.
+    """
+    clauses = []
+    cubes = []
+    for line in text.split("\n"):
+        if line.startswith("a "):
+            cubes.append(line[2:].split()[:-1])
+        elif line and not line.startswith("c") and not line.startswith("p"):
+            clauses.append(line)
+    return clauses, cubes
+
+
+def execute_cubes(path, num_of_cubes, num_of_workers, log=None):
+    """
+    Cube-and-conquer: splits the formula into cubes (see the --cubes option
+    of the translator) and solves every cube as the base formula extended
+    by the cube literals as unit clauses. At most num_of_workers solver
+    processes run at once. The first SAT cube wins and cancels the rest,
+    UNSAT is reported only when every cube is UNSAT. If log is given, it is
+    called with a line containing the wall time of each solved cube and the
+    part of it the solver spent parsing the formula.
+
+    The cubes are not solved incrementally: each cube runs a fresh solver
+    process, which parses the base formula again. The base clauses are only
+    serialized once and copied into each cube's input unchanged.
+    """
+    try:
+        translator = run([TRANSLATOR, "--cubes", str(num_of_cubes), path], stdout=PIPE, stderr=PIPE)
+    except Exception:
+        raise GeneratorError("Error when running formula generator")
+
+    if translator.returncode != 0:
+        raise GeneratorError(translator.stderr.decode().strip())
+
+    input = Input.load(path)
+    clauses, cubes = parse_incremental_formula(translator.stdout.decode())
+    num_of_variables = 2 * input.num_of_regions * input.num_of_products
+
+    cancelled = threading.Event()
+    running = set()
+    lock = threading.Lock()
+
+    # the base clauses are written once, each cube only gets its own header
+    # and unit clauses around a copy of them
+    base_out = TmpFile(mode="w+b")
+    base_out.write("".join(f"{clause}\n" for clause in clauses).encode())
+    base_out.flush()
+
+    def solve_cube(cube):
+        with TmpFile(mode="w+b") as dimacs_out, TmpFile(mode="w+") as model_out:
+            dimacs_out.write(f"p cnf {num_of_variables} {len(clauses) + len(cube)}\n".encode())
+            with open(base_out.name, "rb") as base_in:
+                shutil.copyfileobj(base_in, dimacs_out)
+            dimacs_out.write("".join(f"{literal} 0\n" for literal in cube).encode())
+            dimacs_out.flush()
+
+            start = time.monotonic()
+            with lock:
+                if cancelled.is_set():
+                    return None
+                try:
+                    solver = Popen(
+                        [SOLVER, dimacs_out.name, model_out.name], stdout=PIPE, stderr=PIPE
+                    )
+                except Exception:
+                    raise SolverError("Error when running SAT solver")
+                running.add(solver)
+
+            stdout, stderr = solver.communicate()
+            with lock:
+                running.discard(solver)
+            elapsed = time.monotonic() - start
+
+            if cancelled.is_set():
+                return None
+            if not solver.returncode in [RC_SAT, RC_UNSAT]:
+                raise SolverError(stderr.decode().strip())
+
+            # MiniSat reports how long it took to parse the input
+            parse_time = re.search(r"Parse time:\s*([0-9.]+)", stdout.decode())
+            parse_time = float(parse_time.group(1)) if parse_time else None
+            return Model.load(model_out.name, input), elapsed, parse_time
+
+    with base_out, ThreadPoolExecutor(max_workers=num_of_workers) as executor:
+        futures = {executor.submit(solve_cube, cube): i for (i, cube) in enumerate(cubes)}
+        try:
+            for future in as_completed(futures):
+                result = future.result()
+                if result is None:
+                    continue
+                model, elapsed, parse_time = result
+                if log is not None:
+                    cube = " ".join(cubes[futures[future]])
+                    parse = f" (parse {parse_time:.3f} s)" if parse_time is not None else ""
+                    log(f"cube {futures[future]} [{cube}]: {model.status} in {elapsed:.3f} s{parse}")
+                if model.is_sat():
+                    return model
+        finally:
+            # cancel the remaining cubes and stop the running solvers
+            with lock:
+                cancelled.set()
+                for solver in running:
+                    solver.terminate()
+            executor.shutdown(cancel_futures=True)
+
+    return Model(STATUS_UNSAT, None, input)
+
+
+def run_test_case(path, expected_status, execute=execute, name=""):
     try:
         result = execute(path)
     except GeneratorError:
-        print_err(f"{path}: Generator error")
+        print_err(f"{path}{name}: Generator error")
         return
     except SolverError:
-        print_err(f"{path}: SAT solver error")
+        print_err(f"{path}{name}: SAT solver error")
         return
 
     if expected_status != result.status:
         print_err(
-            f"{path}: Invalid result: got {result.status}, expected {expected_status}"
+            f"{path}{name}: Invalid result: got {result.status}, expected {expected_status}"
         )
     else:
        	try:
             if result.is_sat():
                 result.check()
-            print_ok(f"{path}: OK")
+            print_ok(f"{path}{name}: OK")
         except ModelError as e:
-            print_err(f"{path}: {e}")
+            print_err(f"{path}{name}: {e}")
+
+
+def check_cube_split(path, num_of_cubes=16):
+    """
+    Checks that the translator splits the formula into more than one cube,
+    so that execute_cubes has to combine the answers of several cubes.
+    """
+    name = f" (--cubes {num_of_cubes} split)"
+    translator = run([TRANSLATOR, "--cubes", str(num_of_cubes), path], stdout=PIPE, stderr=PIPE)
+    if translator.returncode != 0:
+        print_err(f"{path}{name}: Generator error")
+        return
+
+    _, cubes = parse_incremental_formula(translator.stdout.decode())
+    if len(cubes) <= 1:
+        print_err(f"{path}{name}: Expected more than one cube, got {len(cubes)}")
+    else:
+        print_ok(f"{path}{name}: OK ({len(cubes)} cubes)")
+
+
+def check_binary_round_trip(path, name=" (--binary)"):
+    """
+    Encodes the formula with --binary, decodes it with --decode and compares
+    the result with the plain DIMACS output without comment lines.
+    """
+    with TmpFile(mode="w+b") as binary_out:
+        plain = run([TRANSLATOR, path], stdout=PIPE, stderr=PIPE)
+        binary = run([TRANSLATOR, "--binary", path], stdout=binary_out, stderr=PIPE)
+        decoded = run([TRANSLATOR, "--decode", binary_out.name], stdout=PIPE, stderr=PIPE)
+
+    if plain.returncode != 0 or binary.returncode != 0 or decoded.returncode != 0:
+        print_err(f"{path}{name}: Generator error")
+        return
+
+    expected = [line for line in plain.stdout.decode().split("\n") if not line.startswith("c")]
+    if decoded.stdout.decode().split("\n") != expected:
+        print_err(f"{path}{name}: Decoded formula differs from the DIMACS output")
+    else:
+        print_ok(f"{path}{name}: OK")
 
 
 def run_test_suite(path, expected_status):
     for test_case in sorted(os.listdir(path)):
         if test_case.endswith(".in"):
-            run_test_case(os.path.join(path, test_case), expected_status)
+            test_path = os.path.join(path, test_case)
+            run_test_case(test_path, expected_status)
+            # the cubes have to cover every solution: some cube of a satisfiable
+            # input is SAT, every cube of an unsatisfiable input is UNSAT
+            # (unless the lookahead refutes the input, which leaves one cube)
+            run_test_case(
+                test_path,
+                expected_status,
+                lambda p: execute_cubes(p, num_of_cubes=16, num_of_workers=4),
+                " (--cubes 16)",
+            )
+            check_binary_round_trip(test_path)
+            # every formula variant has to give the same answer and a model
+            # which is correct after dropping auxiliary and permuted variables
+            for variant in TESTED_VARIANTS:
+                run_test_case(
+                    test_path,
+                    expected_status,
+                    lambda p, variant=variant: execute(p, variant),
+                    f" (--variant {variant})",
+                )
+            run_test_case(
+                test_path,
+                expected_status,
+                lambda p: execute_portfolio(p, 4),
+                " (--portfolio 4)",
+            )
 
 
 if __name__ == "__main__":
     smoke_test()
     run_test_suite("../tests/sat", STATUS_SAT)
     run_test_suite("../tests/unsat", STATUS_UNSAT)
+    # an unsatisfiable input the lookahead cannot refute, so every one of its
+    # cubes has to be solved as UNSAT
+    check_cube_split("../tests/unsat/complete_graph_k7.in")